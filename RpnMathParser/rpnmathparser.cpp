@@ -1,7 +1,9 @@
 #include "rpnmathparser.h"
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <cmath>
+#include <climits>
 #include <QDebug>
 
 RpnMathParser::RpnMathParser() {}
@@ -42,6 +44,40 @@ double RpnMathParser::parseString(QString expression, QString &err) {
     }
 }
 
+/*!
+ * Parses a mathematical expression and evaluates it over complex numbers
+ * \param expression - the mathematical expression
+ * \param err - reference to the debug string
+ * \return the complex result of evaluating the input mathematical expression string and writes "Success!" to err,
+ * if parsing the expression fails, returns NAN and the corresponding error reason in err
+ */
+std::complex<double> RpnMathParser::parseStringComplex(QString expression, QString &err) {
+    MathParserModel model;
+    MathParserController controller(&model);
+
+    // Convert QString to char* for processing
+    QByteArray ba = expression.toLocal8Bit();
+    char *input = ba.data();
+    controller.setErrorString(err);
+
+    if (controller.setInput(input)) {
+        std::complex<double> result = controller.requestComplexCalculations();
+        err = "Success!";
+
+        // NaN in either part means the expression is undefined even over complex numbers
+        if (result.real() != result.real() || result.imag() != result.imag()) {
+            err = "Returned NaN, likely there was an invalid input!";
+            return NAN;
+        }
+        return result;
+    } else {
+        if (err.isEmpty()) {
+            err = "Error: Incorrect expression input!";
+        }
+        return NAN;
+    }
+}
+
 /*!
  * \brief Sets the input string for the MathParserController.
  * \param str Input string to be parsed.
@@ -83,7 +119,37 @@ double MathParserController::requestCalculations() {
         model_->parseStringIntoLexemes();
     }
     model_->makeReversePolishNotationStack();
-    double result = model_->calculateFullExpression();
+
+    // Integer-only expressions are evaluated exactly, everything else (or an overflow) goes through doubles
+    double result;
+    if (!model_->calculateIntegerExpression(result)) {
+        result = model_->calculateFullExpression();
+    }
+
+    // Free data after calculation
+    model_->freeData();
+    return result;
+}
+
+/*!
+ * \brief Requests calculations over complex numbers based on the input string.
+ * \return Returns the result of the calculations as a complex number.
+ */
+std::complex<double> MathParserController::requestComplexCalculations() {
+    if (model_->lexemesList.empty()) {
+        model_->parseStringIntoLexemes();
+    }
+    model_->complexMode = true;
+    model_->makeReversePolishNotationStack();
+
+    std::complex<double> result;
+    double integerResult;
+    if (model_->calculateIntegerExpression(integerResult)) {
+        result = integerResult;
+    } else {
+        double real = model_->calculateFullExpression();
+        result = std::complex<double>(real, model_->readyStack.begin()->imag);
+    }
 
     // Free data after calculation
     model_->freeData();
@@ -105,6 +171,7 @@ MathParserModel::MathParserModel() {
 void MathParserModel::freeData() {
     currentIndex = 0;
     input[0] = '\0';
+    complexMode = false;
     readyStack.clear();
     supportStack.clear();
     lexemesList.clear();
@@ -397,16 +464,16 @@ void MathParserModel::parseStringIntoLexemes() {
  * Adds a number token to the lexeme list
  */
 void MathParserModel::addNumberToList() {
-    double value = 0;
-    int len = 0;
-    sscanf(&input[currentIndex], "%le%n", &value, &len);
+    // strtod/strtol avoid the format string parsing of sscanf on every number
+    char *end = nullptr;
+    double value = strtod(&input[currentIndex], &end);
+    long len = end - &input[currentIndex];
     currentIndex += len;
     if (len == 0) {
         currentIndex += 1;
-        int exp = 0;
-        sscanf(&input[currentIndex], "%d%n", &exp, &len);
+        long exp = strtol(&input[currentIndex], &end, 10);
         (--lexemesList.end())->value = exp;
-        currentIndex += len;
+        currentIndex += end - &input[currentIndex];
         return;
     }
     lexemesList.emplace_back(value, 0, number);
@@ -553,6 +620,10 @@ double MathParserModel::calculateFullExpression() {
     auto prev_prev_it = readyStack.begin();
     auto prev_it = ++readyStack.begin();
     if (readyStack.size() == 2) {
+        // In complex mode the imaginary part has to stay in the stack, so the function is squeezed instead
+        if (complexMode) {
+            return squeezeFunctionResultWithNmb(prev_it, prev_prev_it);
+        }
         return calculateFunction(*prev_it, *prev_prev_it);
     }
     auto current_it = ++(++readyStack.begin());
@@ -570,7 +641,13 @@ double MathParserModel::calculateFullExpression() {
         return squeezeFunctionResultWithNmb(current_it, prev_it);
     }
 
-    prev_prev_it->value = calculateTwoOperators(*prev_prev_it, *prev_it, *current_it);
+    if (complexMode) {
+        std::complex<double> result = calculateComplexTwoOperators(*prev_prev_it, *prev_it, *current_it);
+        prev_prev_it->value = result.real();
+        prev_prev_it->imag = result.imag();
+    } else {
+        prev_prev_it->value = calculateTwoOperators(*prev_prev_it, *prev_it, *current_it);
+    }
     prev_prev_it->type = number;
     prev_prev_it->priority = 0;
     readyStack.erase(current_it);
@@ -585,7 +662,13 @@ double MathParserModel::calculateFullExpression() {
  * \return The result of the expression as a double.
  */
 double MathParserModel::squeezeFunctionResultWithNmb(const list<lexeme>::iterator function, const list<lexeme>::iterator value) {
-    value->value = calculateFunction(*function, *value);
+    if (complexMode) {
+        std::complex<double> result = calculateComplexFunction(*function, *value);
+        value->value = result.real();
+        value->imag = result.imag();
+    } else {
+        value->value = calculateFunction(*function, *value);
+    }
     value->type = number;
     value->priority = 0;
     readyStack.erase(function);
@@ -642,3 +725,176 @@ double MathParserModel::calculateTwoOperators(lexeme operand1, lexeme operand2,
     }
     return return_value;
 }
+
+/*!
+ * \brief Calculates the result of applying a function to a complex value.
+ * Real arguments inside the real domain of the function are passed to calculateFunction(),
+ * so purely real expressions give exactly the same results as in the real mode.
+ * \param function The function lexeme.
+ * \param value The value lexeme.
+ * \return The result of the function as a complex number.
+ */
+std::complex<double> MathParserModel::calculateComplexFunction(const lexeme function, lexeme value) {
+    bool outsideRealDomain = value.value < 0 && (function.type == sqrt_t || function.type == ln_t || function.type == log_t);
+    if (value.imag == 0 && !outsideRealDomain) {
+        return calculateFunction(function, value);
+    }
+
+    std::complex<double> z(value.value, value.imag);
+    std::complex<double> return_value = 0;
+    if (function.type == cos_t) {
+        return_value = std::cos(z);
+    } else if (function.type == sin_t) {
+        return_value = std::sin(z);
+    } else if (function.type == tan_t) {
+        return_value = std::tan(z);
+    } else if (function.type == log_t) {
+        return_value = std::log(z);
+    } else if (function.type == ln_t) {
+        return_value = std::log(z);
+    } else if (function.type == sqrt_t) {
+        return_value = std::sqrt(z);
+    } else if (function.type == abs_t) {
+        return_value = std::abs(z);
+    } else if (function.type == sqr_t) {
+        return_value = z * z;
+    }
+    return return_value;
+}
+
+/*!
+ * \brief Calculates the result of applying an operator to two complex operands.
+ * Real operands are passed to calculateTwoOperators() unless a negative number is raised to a fractional power.
+ * \param operand1 The first operand lexeme.
+ * \param operand2 The second operand lexeme.
+ * \param operation The operator lexeme.
+ * \return The result of the operation as a complex number.
+ */
+std::complex<double> MathParserModel::calculateComplexTwoOperators(lexeme operand1, lexeme operand2, const lexeme operation) {
+    bool fractionalPowerOfNegative = operation.type == pow_t && operand1.value < 0 && operand2.value != std::trunc(operand2.value);
+    if (operand1.imag == 0 && operand2.imag == 0 && !fractionalPowerOfNegative) {
+        return calculateTwoOperators(operand1, operand2, operation);
+    }
+
+    std::complex<double> z1(operand1.value, operand1.imag);
+    std::complex<double> z2(operand2.value, operand2.imag);
+    std::complex<double> return_value = 0;
+    if (operation.type == plus) {
+        return_value = z1 + z2;
+    } else if (operation.type == minus) {
+        return_value = z1 - z2;
+    } else if (operation.type == mult) {
+        return_value = z1 * z2;
+    } else if (operation.type == division) {
+        return_value = z1 / z2;
+    } else if (operation.type == pow_t) {
+        return_value = std::pow(z1, z2);
+    }
+    return return_value;
+}
+
+/*!
+ * \brief Evaluates the ready stack on 64-bit integers if the expression is integer-only.
+ * Integer-only means integer literals not exceeding 2^53 in magnitude combined with +, -, *, ^, abs and sqr.
+ * The ready stack is left untouched, so calculateFullExpression() can be used as a fallback.
+ * \param result Receives the exact result converted to double.
+ * \return false if the expression is not integer-only, raises to a negative power or overflows 64 bits.
+ */
+bool MathParserModel::calculateIntegerExpression(double &result) {
+    const double maxExactInteger = 9007199254740992.0;  // 2^53
+    list<long long> stack;
+
+    for (auto it = readyStack.begin(); it != readyStack.end(); it++) {
+        if (it->type == number) {
+            if (it->value != std::trunc(it->value) || std::fabs(it->value) > maxExactInteger) {
+                return false;
+            }
+            stack.push_front(static_cast<long long>(it->value));
+        } else if (it->type == abs_t || it->type == sqr_t) {
+            long long &value = stack.front();
+            if (it->type == abs_t) {
+                if (value == LLONG_MIN) return false;
+                value = value < 0 ? -value : value;
+            } else if (!multiplyIntegers(value, value, value)) {
+                return false;
+            }
+        } else if (it->type == plus || it->type == minus || it->type == mult || it->type == pow_t) {
+            long long operand2 = stack.front();
+            stack.pop_front();
+            long long &operand1 = stack.front();
+            if (!calculateIntegerTwoOperators(operand1, operand2, it->type, operand1)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+
+    result = static_cast<double>(stack.front());
+    return true;
+}
+
+/*!
+ * \brief Applies an operator to two 64-bit integer operands with overflow detection.
+ * \param operand1 The first operand.
+ * \param operand2 The second operand.
+ * \param operation The operator type (plus, minus, mult or pow_t).
+ * \param result Receives the result of the operation.
+ * \return false on overflow or a negative exponent, true otherwise.
+ */
+bool MathParserModel::calculateIntegerTwoOperators(long long operand1, long long operand2, const lexeme_type operation, long long &result) {
+    if (operation == plus) {
+        if ((operand2 > 0 && operand1 > LLONG_MAX - operand2) || (operand2 < 0 && operand1 < LLONG_MIN - operand2)) {
+            return false;
+        }
+        result = operand1 + operand2;
+        return true;
+    } else if (operation == minus) {
+        if ((operand2 < 0 && operand1 > LLONG_MAX + operand2) || (operand2 > 0 && operand1 < LLONG_MIN + operand2)) {
+            return false;
+        }
+        result = operand1 - operand2;
+        return true;
+    } else if (operation == mult) {
+        return multiplyIntegers(operand1, operand2, result);
+    } else if (operation == pow_t) {
+        if (operand2 < 0) {
+            return false;
+        }
+        // Exponentiation by squaring
+        long long power = 1;
+        while (operand2) {
+            if ((operand2 & 1) && !multiplyIntegers(power, operand1, power)) {
+                return false;
+            }
+            operand2 >>= 1;
+            if (operand2 && !multiplyIntegers(operand1, operand1, operand1)) {
+                return false;
+            }
+        }
+        result = power;
+        return true;
+    }
+    return false;
+}
+
+/*!
+ * \brief Multiplies two 64-bit integers with overflow detection.
+ * \param operand1 The first operand.
+ * \param operand2 The second operand.
+ * \param result Receives the product.
+ * \return false on overflow, true otherwise.
+ */
+bool MathParserModel::multiplyIntegers(long long operand1, long long operand2, long long &result) {
+    if (operand1 > 0) {
+        if ((operand2 > 0 && operand1 > LLONG_MAX / operand2) || (operand2 < 0 && operand2 < LLONG_MIN / operand1)) {
+            return false;
+        }
+    } else if (operand1 < 0) {
+        if ((operand2 > 0 && operand1 < LLONG_MIN / operand2) || (operand2 < 0 && operand1 < LLONG_MAX / operand2)) {
+            return false;
+        }
+    }
+    result = operand1 * operand2;
+    return true;
+}
@@ -2,6 +2,7 @@
 #define RPNMATHPARSER_H
 
 #include <QString>
+#include <complex>
 #include <list>
 using std::list;
 
@@ -24,17 +25,23 @@ public:
 
     bool setInput(const char *str);
     double requestCalculations();
+    std::complex<double> requestComplexCalculations();
     void freeCalcData();
     void setErrorString(QString &err);
 };
 
 /*!
  * \brief A facade class providing tools for parsing mathematical expressions
+ *
+ * \details
+ * parseStringComplex() evaluates the same expressions over complex numbers, so sqrt, ln, log and ^
+ * of negative arguments return a complex result instead of NaN
  */
 class RpnMathParser {
 public:
     RpnMathParser();
     static double parseString(QString expression, QString &err);
+    static std::complex<double> parseStringComplex(QString expression, QString &err);
 };
 
 /*!
@@ -46,6 +53,7 @@ public:
 class MathParserModel {
     friend bool MathParserController::setInput(const char *str);
     friend double MathParserController::requestCalculations();
+    friend std::complex<double> MathParserController::requestComplexCalculations();
     friend void MathParserController::freeCalcData();
     friend void MathParserController::setErrorString(QString &err);
 public:
@@ -56,6 +64,7 @@ private:
     char input[256];
     unsigned currentIndex;
     QString *errorString;
+    bool complexMode;
 
     void freeData();
     void setErrorString(QString &err);
@@ -81,16 +90,19 @@ private:
      * \brief Lexeme structure for parsing a mathematical expression
      *
      * \details
-     * value - value;
+     * value - value (real part in complex mode);
+     * imag - imaginary part, used only in complex mode;
      * priority - priority;
      * lexeme_type - type of lexeme;
      */
     struct lexeme {
         double value;
+        double imag;
         int priority;
         lexeme_type type;
         lexeme(double val, int prio, lexeme_type t) {
             value = val;
+            imag = 0;
             priority = prio;
             type = t;
         }
@@ -117,6 +129,13 @@ private:
     double calculateFunction(const lexeme function, lexeme value);
     double squeezeFunctionResultWithNmb(const iterator function, const iterator value);
     double calculateTwoOperators(lexeme operand1, lexeme operand2, const lexeme operation);
+    std::complex<double> calculateComplexFunction(const lexeme function, lexeme value);
+    std::complex<double> calculateComplexTwoOperators(lexeme operand1, lexeme operand2, const lexeme operation);
+
+    // Functions for exact evaluation of integer-only expressions
+    bool calculateIntegerExpression(double &result);
+    bool calculateIntegerTwoOperators(long long operand1, long long operand2, const lexeme_type operation, long long &result);
+    bool multiplyIntegers(long long operand1, long long operand2, long long &result);
 };
 
 #endif // RPNMATHPARSER_H